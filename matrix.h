@@ -9,7 +9,9 @@
 #include <vector>
 #include <functional>
 #include <cstddef>
+#include <cstdint>
 #include <utility>
+#include <type_traits>
 
 #if !defined(__cplusplus)
 #error "Unable to determine C++ version in use"
@@ -39,6 +41,53 @@ public:
      */
     typedef std::size_t size_type;
 
+    /*!
+     * @brief Enumeration denoting the method used by the exact
+     *        elimination functions, determinant(), rank(), and solve()
+     *
+     * `BAREISS` performs fraction-free elimination directly on the
+     * elements. It is always exact, but every intermediate value must
+     * be representable, so it is only suitable for small matrices or
+     * small elements.
+     *
+     * `MODULAR` performs the elimination modulo a number of 31-bit
+     * primes, in parallel, and reconstructs the result using the
+     * Chinese remainder theorem. Intermediate values never overflow,
+     * so only the result must be representable. Every result is proven:
+     * the number of primes is chosen using the Hadamard bound on the
+     * result, so that their product exceeds twice the bound. A result
+     * that isn't representable is found using only as many primes as
+     * required to cover the range of the element type. The number of
+     * primes used to find a rank less than the number of rows and
+     * columns depends on the bound on the minors one larger than that
+     * rank; a full rank is found using a single prime. For large
+     * matrices with large elements, the number of primes, each costing
+     * an elimination, can be in the thousands.
+     *
+     * `RANDOMIZED` is the same as `MODULAR`, except that the primes are
+     * chosen at random from those between 2^30 and 2^31, and that the
+     * results (including zero determinants, singular systems, and ranks
+     * less than full) are accepted once enough additional primes agree on
+     * them that the probability of an incorrect result is less than 2^-64,
+     * regardless of the matrix. This usually takes a handful of primes.
+     * Since the primes are random, no particular matrix is more likely
+     * than any other to produce an incorrect result.
+     *
+     * Since the results are returned as elements, the results for large
+     * matrices with large elements, e.g. the determinant of a `2000 x
+     * 2000` matrix of 64-bit values, are usually not representable, and
+     * std::overflow_error is thrown.
+     *
+     * @note An explanation of the Bareiss algorithm can be found at:
+     *       https://en.wikipedia.org/wiki/Bareiss_algorithm
+     */
+    typedef enum
+    {
+        BAREISS,
+        MODULAR,
+        RANDOMIZED,
+    } elimination_type;
+
     virtual ~matrix(void);
 
     /*!
@@ -234,6 +283,10 @@ public:
      *
      * Two matrices compare as equal when they are dimensionally equivalent,
      * and all elements in each of the corresponding locations are equal.
+     * Matrices of different dimensions are rejected without examining any
+     * elements, and the elements are compared a row or column at a time
+     * (or, if the matrices are stored in different orders, a tile at a
+     * time), stopping at the first difference.
      *
      * @retval true The matrices are equivalent
      * @retval false The matrices are not equivalent
@@ -296,6 +349,162 @@ public:
     void transform(const std::function<element_type(size_type, size_type,
                                                     element_type)> & xfrm);
 
+    /*!
+     * @brief Compute the sum of all elements in a matrix
+     *
+     * The sum of an empty matrix is zero. For large matrices, the
+     * work is divided among multiple threads, and the partial results
+     * are combined pairwise.
+     *
+     * @return The sum of all elements
+     */
+    element_type sum(void) const;
+    /*!
+     * @brief Find the smallest element in a matrix
+     *
+     * If the matrix is empty, std::domain_error is thrown.
+     *
+     * @return The value of the smallest element
+     */
+    element_type min(void) const;
+    /*!
+     * @brief Find the largest element in a matrix
+     *
+     * If the matrix is empty, std::domain_error is thrown.
+     *
+     * @return The value of the largest element
+     */
+    element_type max(void) const;
+    /*!
+     * @brief Find the location of the smallest element in a matrix
+     *
+     * If the smallest value occurs more than once, the location of the
+     * first occurrence (in row-by-row order) is returned. If the matrix
+     * is empty, std::domain_error is thrown.
+     *
+     * @return A pair, the first element of which is the row
+     *         and the second of which is the column of the
+     *         smallest element
+     */
+    std::pair<size_type, size_type> argmin(void) const;
+    /*!
+     * @brief Find the location of the largest element in a matrix
+     *
+     * @see argmin()
+     */
+    std::pair<size_type, size_type> argmax(void) const;
+
+    /*!
+     * @brief Compute the trace of a matrix
+     *
+     * The trace is the sum of the elements on the main diagonal. If the
+     * matrix is not square, std::domain_error is thrown.
+     *
+     * @note An explanation of the trace can be found at:
+     *       https://en.wikipedia.org/wiki/Trace_(linear_algebra)
+     */
+    element_type trace(void) const;
+
+    /*!
+     * @brief Compute the 1-norm of a matrix
+     *
+     * The 1-norm is the largest sum of the absolute
+     * values of the elements in any one column.
+     *
+     * @note An explanation of the matrix norms can be found at:
+     *       https://en.wikipedia.org/wiki/Matrix_norm
+     */
+    element_type norm1(void) const;
+    /*!
+     * @brief Compute the infinity-norm of a matrix
+     *
+     * The infinity-norm is the largest sum of the absolute
+     * values of the elements in any one row.
+     *
+     * @see norm1()
+     */
+    element_type norm_inf(void) const;
+
+    /*!
+     * @brief Compute a hash of the contents of a matrix
+     *
+     * Equal matrices always produce equal hashes, so comparing hashes
+     * that were stored earlier is a cheap way to detect that a matrix
+     * has changed. Equal hashes do not guarantee equal matrices.
+     *
+     * @return The hash of the dimensions and elements of the matrix
+     */
+    std::size_t hash(void) const;
+
+    /*!
+     * @brief Compute the determinant of a matrix exactly
+     *
+     * If the matrix is not square, std::domain_error is thrown. If the
+     * determinant (or, using the `BAREISS` method, any intermediate value)
+     * can't be represented by the element type, std::overflow_error is
+     * thrown. Values equal to the most negative value of the element type
+     * are treated as unrepresentable. The determinant of an empty matrix
+     * is one.
+     *
+     * The complexity of this operation is `n^3` for each prime used by
+     * the `MODULAR` and `RANDOMIZED` methods or `n^3` multiplications and
+     * divisions of values twice the width of the elements for the
+     * `BAREISS` method, where the matrix is `n x n`.
+     *
+     * @param[in] method The method used to perform the elimination
+     *
+     * @note The element type must be signed
+     *
+     * @note An explanation of the determinant can be found at:
+     *       https://en.wikipedia.org/wiki/Determinant
+     */
+    element_type determinant(elimination_type method = BAREISS) const;
+    /*!
+     * @brief Compute the rank of a matrix exactly
+     *
+     * The rank is the number of linearly independent rows (or columns)
+     * in the matrix. Using the `BAREISS` method, std::overflow_error is
+     * thrown if an intermediate value can't be represented by the element
+     * type. The `MODULAR` and `RANDOMIZED` methods never throw
+     * std::overflow_error.
+     *
+     * @param[in] method The method used to perform the elimination
+     *
+     * @note The element type must be signed
+     *
+     * @see determinant()
+     */
+    size_type rank(elimination_type method = BAREISS) const;
+    /*!
+     * @brief Solve a system of linear equations exactly
+     *
+     * Find `x` such that `*this * x == rhs`. Since the solution need not
+     * consist of integers, the result is given as a matrix of numerators,
+     * `X`, and a positive common denominator, `d`, the absolute value of
+     * the determinant of `*this`, such that `*this * X == rhs * d`.
+     *
+     * If `*this` is not square, or the number of rows in `rhs` is not
+     * equal to the number of rows in `*this`, or `*this` is singular,
+     * std::domain_error is thrown. If any part of the result (or, using
+     * the `BAREISS` method, any intermediate value) can't be represented
+     * by the element type, std::overflow_error is thrown.
+     *
+     * @param[in] rhs The right-hand side of the system. Each column of
+     *                `rhs` is solved as a separate system.
+     * @param[in] method The method used to perform the elimination
+     *
+     * @return A pair, the first element of which is the matrix of
+     *         numerators, `X`, and the second of which is the
+     *         denominator, `d`
+     *
+     * @note The element type must be signed
+     *
+     * @see determinant()
+     */
+    std::pair<matrix<element_type>, element_type> solve(
+        const matrix<element_type> & rhs,
+        elimination_type method = BAREISS) const;
+
 private:
     /*!
      * @brief Enumeration denoting whether the matrix is
@@ -343,6 +552,339 @@ private:
     std::pair<size_type, size_type> foreach(
         const std::function<bool(size_type, size_type,
                                  element_type)> & each) const;
+
+    /*!
+     * @brief Reduce the elements of the matrix to a single value
+     *
+     * The vectors that make up the internal representation of the matrix
+     * (rows or columns, depending on the order) are divided into ranges,
+     * and each range is reduced, possibly in its own thread, by calling
+     * the kernel for each vector in the range. The results from each range
+     * are then combined pairwise until a single result remains.
+     *
+     * @param[in] init The initial value of the result for each range
+     * @param[in] kernel The function, lambda, etc. to call for each
+     *                   vector. The function is supplied with the
+     *                   result so far, a pointer to the elements of
+     *                   the vector, the number of elements, and the
+     *                   index of the vector within the matrix.
+     * @param[in] combine The function, lambda, etc. to call to combine
+     *                    the second result into the first
+     *
+     * @return The combined result
+     */
+    template <typename R>
+    R reduce(const R & init,
+             const std::function<void(R &, const element_type *,
+                                      size_type, size_type)> & kernel,
+             const std::function<void(R &, const R &)> & combine) const;
+
+    /*!
+     * @brief Perform a number of independent tasks in parallel
+     *
+     * The tasks are divided among as many threads as the hardware
+     * supports, with the calling thread performing its share. The
+     * function returns after all tasks have been completed.
+     *
+     * @param[in] tasks The number of tasks
+     * @param[in] cost The (approximate) number of operations, e.g. elements
+     *                 visited or multiply-adds, performed by each task.
+     *                 Fewer threads are used, down to just the calling
+     *                 thread, if there isn't enough work for each.
+     * @param[in] work The function, lambda, etc. to call to perform
+     *                 each task. The function is supplied with the
+     *                 index of the task, from zero to `tasks - 1`.
+     */
+    static void parallel(size_type tasks, size_type cost,
+                         const std::function<void(size_type)> & work);
+
+    /*!
+     * @brief Sum a contiguous range of elements
+     *
+     * The sum is computed using multiple independent accumulators
+     * so that the compiler is able to vectorize the loop.
+     */
+    static element_type sum(const element_type * elements, size_type count);
+    /*!
+     * @brief Sum the absolute values of a contiguous range of elements
+     *
+     * @see sum(const element_type *, size_type)
+     */
+    static element_type abs_sum(const element_type * elements,
+                                size_type count);
+    /*!
+     * @brief Find the smallest of a contiguous, non-empty range of elements
+     *
+     * @see sum(const element_type *, size_type)
+     */
+    static element_type min(const element_type * elements, size_type count);
+    /*!
+     * @brief Find the largest of a contiguous, non-empty range of elements
+     *
+     * @see sum(const element_type *, size_type)
+     */
+    static element_type max(const element_type * elements, size_type count);
+
+    /*!
+     * @brief Scatter the bits of a value, for hashing
+     *
+     * @see hash()
+     */
+    static std::uint64_t mix(std::uint64_t x);
+
+    /*!
+     * @brief Find the location of the smallest or largest element
+     *
+     * @param[in] largest `true` to find the largest element,
+     *                    `false` to find the smallest
+     *
+     * @see argmin()
+     */
+    std::pair<size_type, size_type> argextreme(bool largest) const;
+
+    /*!
+     * @brief Compute the largest sum of the absolute values
+     *        of the elements in any one row or column
+     *
+     * @param[in] order Whether to sum the rows (ROWS) or
+     *                  the columns (COLS) of the matrix
+     *
+     * @see norm1()
+     * @see norm_inf()
+     */
+    element_type norm(order_type order) const;
+
+#if defined(__SIZEOF_INT128__)
+    /*!
+     * @brief The widest signed integral type available
+     */
+    __extension__ typedef __int128 widest_type;
+#else
+    typedef long long widest_type;
+#endif
+    /*!
+     * @brief A signed type able to hold the product of two elements
+     *
+     * This is the type in which the Bareiss algorithm does its arithmetic.
+     */
+    typedef typename std::conditional<
+        (sizeof(element_type) < sizeof(long long)),
+        long long, widest_type>::type wide_type;
+    /*!
+     * @brief The type in which modular arithmetic is performed
+     *
+     * The moduli are less than 2^31, so the product
+     * of two residues always fits in this type.
+     */
+    typedef std::uint64_t residue_type;
+
+    /*!
+     * @brief Get the rows of the matrix, or of its transposition
+     *
+     * @param[in] order ROWS to get the rows of the matrix or COLS to get
+     *                  the rows of the transposition of the matrix
+     *
+     * @return The elements of the matrix in the requested order
+     */
+    std::vector<std::vector<element_type>> vectors(order_type order) const;
+
+    /*!
+     * @brief Convert a wide value to the element type
+     *
+     * If the value can't be represented by the element
+     * type, std::overflow_error is thrown.
+     */
+    static element_type narrow(wide_type val);
+    /*!
+     * @brief Add two wide values
+     *
+     * Both values must have magnitudes no greater than the square
+     * of the largest element. If the sum exceeds that magnitude,
+     * std::overflow_error is thrown.
+     */
+    static wide_type add(wide_type lhs, wide_type rhs);
+
+    /*!
+     * @brief Perform fraction-free elimination on a set of rows
+     *
+     * The rows are reduced to an echelon form in which the last pivot
+     * is the determinant of the square matrix formed by the pivot rows
+     * and columns. Rows are exchanged to find pivots.
+     *
+     * @param[in,out] rows The rows to be reduced
+     * @param[in] cols The number of columns, starting from the first, in
+     *                 which to search for pivots. The remaining columns
+     *                 are carried along with their rows.
+     * @param[out] sign The sign of the permutation of the rows, either
+     *                  one or negative one
+     *
+     * @return The rank, i.e. the number of pivots found
+     */
+    static size_type bareiss(std::vector<std::vector<element_type>> & rows,
+                             size_type cols, element_type & sign);
+
+    /*!
+     * @brief Compute the Euclidean lengths of a set of rows
+     *
+     * Rows shorter than one are counted as having length one.
+     *
+     * @param[in] rows The rows whose lengths are computed
+     * @param[in] cols The number of columns, starting from the first, that
+     *                 are part of the matrix. The rest of each row is treated
+     *                 as a set of alternative columns, of which only the
+     *                 largest contributes to the length.
+     *
+     * @return The base 2 logarithms of the lengths
+     */
+    static std::vector<double> lengths(
+        const std::vector<std::vector<element_type>> & rows, size_type cols);
+    /*!
+     * @brief Compute the Hadamard bound for a set of rows
+     *
+     * The bound is the product of the lengths of the rows, and no square
+     * submatrix formed from the rows has a determinant whose magnitude
+     * exceeds it.
+     *
+     * @param[in] rows The rows for which to compute the bound
+     * @param[in] cols The number of columns that are part of the matrix
+     *
+     * @return The base 2 logarithm of the bound
+     *
+     * @see lengths()
+     *
+     * @note An explanation of the bound can be found at:
+     *       https://en.wikipedia.org/wiki/Hadamard%27s_inequality
+     */
+    static double hadamard(const std::vector<std::vector<element_type>> & rows,
+                           size_type cols);
+    /*!
+     * @brief Compute the Hadamard bound for the determinant of any
+     *        square submatrix of the matrix
+     *
+     * @return The base 2 logarithm of the smaller of the
+     *         bounds computed from the rows and from the columns
+     */
+    double hadamard(void) const;
+    /*!
+     * @brief Find the number of primes required for modular elimination
+     *
+     * @param[in] bits The base 2 logarithm of a bound on
+     *                 the magnitude of the desired result
+     *
+     * @return The number of primes whose product exceeds twice the bound
+     */
+    static size_type moduli(double bits);
+    /*!
+     * @brief Find the number of random primes required to confirm a result
+     *
+     * @param[in] bits The base 2 logarithm of a bound on
+     *                 the magnitude of the desired result
+     *
+     * @return The number of random primes that must agree on a result
+     *         for the probability that it's incorrect to be less than
+     *         2^-64, or moduli(), if that is fewer
+     */
+    static size_type confirmations(double bits);
+    /*!
+     * @brief Determine whether a number is prime
+     */
+    static bool prime(residue_type c);
+    /*!
+     * @brief Get primes less than 2^31 that haven't been used yet
+     *
+     * Using the `MODULAR` method, the primes are the largest that
+     * haven't been used, in descending order. Using the `RANDOMIZED`
+     * method, they're chosen at random from those between 2^30 and 2^31.
+     *
+     * @param[in] count The number of primes
+     * @param[in] method The method of elimination
+     * @param[in,out] used The primes used so far, to
+     *                     which the new primes are added
+     *
+     * @return The new primes
+     */
+    static std::vector<residue_type> primes(size_type count,
+                                            elimination_type method,
+                                            std::vector<residue_type> & used);
+    /*!
+     * @brief Find a set of values from their residues modulo many primes
+     *
+     * The primes are chosen, and the values accepted, as described by
+     * `MODULAR` and `RANDOMIZED`. If the values can't be represented by
+     * the element type, std::overflow_error is thrown.
+     *
+     * @param[in] method The method of elimination
+     * @param[in] bits The base 2 logarithm of a bound on
+     *                 the magnitude of the values
+     * @param[in] singular The base 2 logarithm of a bound on the magnitude
+     *                     of the determinant that makes primes unusable
+     * @param[in] count The number of values
+     * @param[in] cost The number of operations performed for each prime
+     * @param[in] residues A function that finds the residues of the values
+     *                     modulo the given prime, returning `false` if the
+     *                     prime is unusable, because it divides the
+     *                     determinant. It may be called concurrently.
+     * @param[out] values The values
+     *
+     * @return `false` if the determinant is zero, or `true`
+     */
+    static bool recover(
+        elimination_type method, double bits, double singular,
+        size_type count, size_type cost,
+        const std::function<bool(residue_type,
+                                 std::vector<residue_type> &)> & residues,
+        std::vector<element_type> & values);
+    /*!
+     * @brief Raise a residue to a power modulo a prime
+     */
+    static residue_type power(residue_type base, residue_type exp,
+                              residue_type p);
+
+    /*!
+     * @brief Perform Gaussian elimination modulo a prime on a set of rows
+     *
+     * @param[in,out] rows The rows to be reduced, with elements in the
+     *                     range [0, p). Upon return, the rows are in
+     *                     echelon form.
+     * @param[in] cols The number of columns, starting from the first, in
+     *                 which to search for pivots. The remaining columns
+     *                 are carried along with their rows.
+     * @param[in] p The prime modulus
+     * @param[out] det The product of the pivots and the sign of the
+     *                 permutation of the rows, modulo `p`
+     *
+     * @return The rank, i.e. the number of pivots found
+     */
+    static size_type eliminate(std::vector<std::vector<residue_type>> & rows,
+                               size_type cols, residue_type p,
+                               residue_type & det);
+    /*!
+     * @brief Reduce a set of rows modulo a prime
+     *
+     * @param[in] rows The rows to be reduced
+     * @param[in] p The prime modulus
+     *
+     * @return The residues, in the range [0, p), of the elements
+     */
+    static std::vector<std::vector<residue_type>> residues(
+        const std::vector<std::vector<element_type>> & rows,
+        residue_type p);
+
+    /*!
+     * @brief Reconstruct a value from its residues modulo a set of primes
+     *
+     * The value is the one with the smallest magnitude that is congruent
+     * to each of the residues. If it can't be represented by the element
+     * type, std::overflow_error is thrown.
+     *
+     * @param[in] res The residues
+     * @param[in] p The primes, the same number as there are residues
+     *
+     * @note An explanation of the Chinese remainder theorem can be found at:
+     *       https://en.wikipedia.org/wiki/Chinese_remainder_theorem
+     */
+    static element_type reconstruct(const std::vector<residue_type> & res,
+                                    const std::vector<residue_type> & p);
 };
 
 #include "matrix.tpp"
@@ -4,6 +4,14 @@
 #include <algorithm>
 #include <sstream>
 #include <stdexcept>
+#include <cstring>
+#include <cstdint>
+#include <thread>
+#include <system_error>
+#include <exception>
+#include <limits>
+#include <cmath>
+#include <random>
 
 template <typename T>
 matrix<T>::~matrix(void)
@@ -285,25 +293,75 @@ matrix<T> & matrix<T>::operator *=(const element_type & rhs)
 template <typename T>
 bool matrix<T>::operator ==(const matrix<element_type> & rhs) const
 {
-    const std::function<bool(size_type, size_type, element_type)> each =
-        [&rhs]
-        (const size_type row,
-         const size_type col,
-         const element_type val)
-        {
-            /*
-             * for each element provided, verify that
-             * the corresponding element in rhs is equal
-             */
-            return val == rhs(row, col);
-        };
+    size_type i, j;
+
+    /* a matrix is always equal to itself */
+    if (this == &rhs) {
+        return true;
+    }
 
     /*
      * verify that the two matrices are the same size
-     * and if so, verify each value within
+     * before looking at any of the elements
      */
-    const std::pair<size_type, size_type> this_size = size();
-    return this_size == rhs.size() && this_size == foreach(each);
+    if (size() != rhs.size()) {
+        return false;
+    }
+
+    /*
+     * the matrices are the same size, so if they're stored in the
+     * same order, their internal vectors are all the same length
+     * and can be compared directly
+     */
+    if (_order == rhs._order) {
+        for (i = 0; i < _elements.size(); i++) {
+            if (std::memcmp(_elements[i].data(), rhs._elements[i].data(),
+                            _elements[i].size() * sizeof(element_type))) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /*
+     * otherwise, the rows of one are the columns of the other. walking
+     * the vectors of *this sequentially would read each element of rhs
+     * from a different vector, so the comparison is done in square
+     * tiles. the part of each vector within a tile is short enough that
+     * all of them, from both matrices, stay in cache until the tile is
+     * done.
+     */
+    const size_type tile = 64;
+    const size_type vectors = _elements.size();
+    const size_type length = vectors ? _elements[0].size() : 0;
+
+    for (size_type ti = 0; ti < vectors; ti += tile) {
+        const size_type ei = std::min(ti + tile, vectors);
+
+        for (size_type tj = 0; tj < length; tj += tile) {
+            const size_type ej = std::min(tj + tile, length);
+
+            /* the vectors of rhs that cross the tile */
+            const element_type * other[tile];
+
+            for (j = tj; j < ej; j++) {
+                other[j - tj] = rhs._elements[j].data();
+            }
+
+            for (i = ti; i < ei; i++) {
+                const element_type * const vec = _elements[i].data();
+
+                for (j = tj; j < ej; j++) {
+                    if (vec[j] != other[j - tj][i]) {
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+
+    return true;
 }
 
 /* matrix inequality operator */
@@ -436,6 +494,1494 @@ matrix<T>::foreach(const std::function<bool(size_type, size_type,
     return std::make_pair(i, j);
 }
 
+/* sum all elements */
+template <typename T>
+T matrix<T>::sum(void) const
+{
+    return reduce<element_type>(
+        0,
+        []
+        (element_type & res,
+         const element_type * const elements,
+         const size_type count,
+         const size_type /* ignored */)
+        {
+            res += sum(elements, count);
+        },
+        []
+        (element_type & res, const element_type & other)
+        {
+            res += other;
+        });
+}
+
+/* find the smallest element */
+template <typename T>
+T matrix<T>::min(void) const
+{
+    if (empty()) {
+        throw std::domain_error("empty matrix has no minimum");
+    }
+
+    /* the first element is a valid starting point for every range */
+    return reduce<element_type>(
+        _elements[0][0],
+        []
+        (element_type & res,
+         const element_type * const elements,
+         const size_type count,
+         const size_type /* ignored */)
+        {
+            res = std::min(res, min(elements, count));
+        },
+        []
+        (element_type & res, const element_type & other)
+        {
+            res = std::min(res, other);
+        });
+}
+
+/* find the largest element */
+template <typename T>
+T matrix<T>::max(void) const
+{
+    if (empty()) {
+        throw std::domain_error("empty matrix has no maximum");
+    }
+
+    return reduce<element_type>(
+        _elements[0][0],
+        []
+        (element_type & res,
+         const element_type * const elements,
+         const size_type count,
+         const size_type /* ignored */)
+        {
+            res = std::max(res, max(elements, count));
+        },
+        []
+        (element_type & res, const element_type & other)
+        {
+            res = std::max(res, other);
+        });
+}
+
+/* find the location of the smallest element */
+template <typename T>
+std::pair<typename matrix<T>::size_type,
+          typename matrix<T>::size_type>
+matrix<T>::argmin(void) const
+{
+    return argextreme(false);
+}
+
+/* find the location of the largest element */
+template <typename T>
+std::pair<typename matrix<T>::size_type,
+          typename matrix<T>::size_type>
+matrix<T>::argmax(void) const
+{
+    return argextreme(true);
+}
+
+/* sum the elements on the diagonal */
+template <typename T>
+T matrix<T>::trace(void) const
+{
+    const std::pair<size_type, size_type> this_size = size();
+    element_type res = 0;
+
+    if (this_size.first != this_size.second) {
+        std::stringstream ss;
+
+        ss << "trace of non-square matrix: ";
+        ss << "(" << this_size.first << "x" << this_size.second << ")";
+
+        throw std::domain_error(ss.str());
+    }
+
+    /* the diagonal is the same regardless of the order */
+    for (size_type i = 0; i < this_size.first; i++) {
+        res += _elements[i][i];
+    }
+
+    return res;
+}
+
+/* largest absolute column sum */
+template <typename T>
+T matrix<T>::norm1(void) const
+{
+    return norm(COLS);
+}
+
+/* largest absolute row sum */
+template <typename T>
+T matrix<T>::norm_inf(void) const
+{
+    return norm(ROWS);
+}
+
+/* hash the dimensions and elements */
+template <typename T>
+std::size_t matrix<T>::hash(void) const
+{
+    const std::pair<size_type, size_type> this_size = size();
+    const order_type order = _order;
+
+    /*
+     * each element is hashed along with its location, and the
+     * results are added together. addition doesn't depend on the
+     * order in which the elements are visited, so the hash is the
+     * same regardless of how the matrix is stored or divided up.
+     */
+    std::uint64_t res = reduce<std::uint64_t>(
+        0,
+        [&this_size, order]
+        (std::uint64_t & res,
+         const element_type * const elements,
+         const size_type count,
+         const size_type vec)
+        {
+            /*
+             * the location of each element, in row-by-row order, is
+             * first + i * step. keeping it linear in i (rather than
+             * choosing the row and column for each element) lets the
+             * compiler vectorize the loop.
+             */
+            const std::uint64_t first =
+                (order == ROWS) ? vec * this_size.second : vec;
+            const std::uint64_t step =
+                (order == ROWS) ? 1 : this_size.second;
+            std::uint64_t acc = 0;
+
+            for (size_type i = 0; i < count; i++) {
+                acc += mix((first + i * step) * UINT64_C(0x9e3779b97f4a7c15) +
+                           static_cast<std::uint64_t>(elements[i]));
+            }
+
+            res += acc;
+        },
+        []
+        (std::uint64_t & res, const std::uint64_t & other)
+        {
+            res += other;
+        });
+
+    res ^= mix(this_size.first * UINT64_C(0x9e3779b97f4a7c15) +
+               this_size.second);
+
+    return static_cast<std::size_t>(mix(res));
+}
+
+/* exact determinant */
+template <typename T>
+T matrix<T>::determinant(const elimination_type method) const
+{
+    static_assert(std::is_signed<element_type>::value,
+                  "exact elimination requires signed elements");
+
+    const std::pair<size_type, size_type> this_size = size();
+
+    if (this_size.first != this_size.second) {
+        std::stringstream ss;
+
+        ss << "determinant of non-square matrix: ";
+        ss << "(" << this_size.first << "x" << this_size.second << ")";
+
+        throw std::domain_error(ss.str());
+    }
+
+    if (empty()) {
+        return 1;
+    }
+
+    /*
+     * the determinant of the transposition is the same as that
+     * of the matrix, so the vectors can be used as the rows
+     * regardless of the order in which they're stored
+     */
+    if (method == BAREISS) {
+        std::vector<std::vector<element_type>> rows(_elements);
+        element_type sign;
+
+        if (bareiss(rows, this_size.first, sign) < this_size.first) {
+            return 0;
+        }
+
+        return narrow(static_cast<wide_type>(sign) * rows.back().back());
+    } else {
+        /*
+         * a prime that divides the determinant tells nothing about
+         * it other than that, so it's treated as unusable. once enough
+         * primes divide it, it's zero (see recover()).
+         */
+        const size_type n = this_size.first;
+        const double bits = hadamard();
+        std::vector<element_type> res;
+
+        /*
+         * an elimination is about n^3 / 3 multiply-adds, on
+         * top of the n^2 operations to find the residues
+         */
+        if (!recover(method, bits, bits, 1, n * n * (n + 3) / 3,
+                     [this, &this_size]
+                     (const residue_type p, std::vector<residue_type> & det)
+                     {
+                         std::vector<std::vector<residue_type>> rows =
+                             residues(_elements, p);
+
+                         eliminate(rows, this_size.first, p, det[0]);
+                         return det[0] != 0;
+                     },
+                     res)) {
+            return 0;
+        }
+
+        return res[0];
+    }
+}
+
+/* exact rank */
+template <typename T>
+typename matrix<T>::size_type
+matrix<T>::rank(const elimination_type method) const
+{
+    static_assert(std::is_signed<element_type>::value,
+                  "exact elimination requires signed elements");
+
+    const size_type cols = empty() ? 0 : _elements[0].size();
+
+    /* the rank of the transposition is the same as that of the matrix */
+    if (method == BAREISS) {
+        std::vector<std::vector<element_type>> rows(_elements);
+        element_type sign;
+
+        return bareiss(rows, cols, sign);
+    } else {
+        /*
+         * the rank modulo a prime can be less than the true rank, r, but
+         * only if the prime divides every one of the r x r minors. so, if
+         * the largest rank found so far is k < r, every prime that has
+         * been tried divides some non-zero (k + 1) x (k + 1) minor. the
+         * product of the k + 1 longest rows (or columns) bounds every such
+         * minor, so once enough primes have been tried to rule out one
+         * that they all divide (see recover()), the rank is k.
+         *
+         * this makes the number of primes depend on the rank: a full
+         * rank needs just the one prime that finds it.
+         */
+        const order_type other = (_order == ROWS) ? COLS : ROWS;
+        const size_type most = std::min(_elements.size(), cols);
+        const size_type batch = std::max<size_type>(
+            std::thread::hardware_concurrency(), 1);
+
+        std::vector<double> rlen = lengths(_elements, cols);
+        std::vector<double> clen = lengths(vectors(other),
+                                           _elements.size());
+        std::vector<residue_type> used;
+        size_type rank = 0;
+        size_type k;
+
+        std::sort(rlen.begin(), rlen.end(), std::greater<double>());
+        std::sort(clen.begin(), clen.end(), std::greater<double>());
+
+        /* turn the lengths into bounds on the minors of each size */
+        for (k = 1; k < most; k++) {
+            rlen[k] += rlen[k - 1];
+            clen[k] += clen[k - 1];
+        }
+
+        while (rank < most) {
+            const double bits = std::min(rlen[rank], clen[rank]);
+            const size_type want = (method == MODULAR) ?
+                moduli(bits) : confirmations(bits);
+
+            if (used.size() >= want) {
+                break;
+            }
+
+            const std::vector<residue_type> p =
+                primes(std::min(batch, want - used.size()), method, used);
+            std::vector<size_type> res(p.size());
+
+            parallel(
+                p.size(), _elements.size() * cols * (most + 3) / 3,
+                [this, &p, &res, cols]
+                (const size_type i)
+                {
+                    std::vector<std::vector<residue_type>> rows =
+                        residues(_elements, p[i]);
+                    residue_type det;
+
+                    res[i] = eliminate(rows, cols, p[i], det);
+                });
+
+            rank = std::max(rank, *std::max_element(res.begin(), res.end()));
+        }
+
+        return rank;
+    }
+}
+
+/* exact solution of a linear system */
+template <typename T>
+std::pair<matrix<T>, T>
+matrix<T>::solve(const matrix<element_type> & rhs,
+                 const elimination_type method) const
+{
+    static_assert(std::is_signed<element_type>::value,
+                  "exact elimination requires signed elements");
+
+    const size_type n = size().first;
+    const size_type q = rhs.size().second;
+
+    if (n != size().second || n != rhs.size().first) {
+        std::stringstream ss;
+
+        ss << "incompatible dimensions for linear system: ";
+        ss << "(" << n << "x" << size().second << ")";
+        ss << " vs. ";
+        ss << "(" << rhs.size().first << "x" << q << ")";
+
+        throw std::domain_error(ss.str());
+    }
+
+    /* the solution of an empty system is empty */
+    if (n == 0) {
+        return std::make_pair(matrix<element_type>(), element_type(1));
+    }
+
+    matrix<element_type> res(n, q);
+    element_type den;
+
+    /*
+     * form the augmented matrix, [ *this | rhs ], in which
+     * the pivots are only searched for in the first n columns
+     */
+    std::vector<std::vector<element_type>> rows = vectors(ROWS);
+    const std::vector<std::vector<element_type>> b = rhs.vectors(ROWS);
+
+    for (size_type i = 0; i < n; i++) {
+        rows[i].insert(rows[i].end(), b[i].begin(), b[i].end());
+    }
+
+    if (method == BAREISS) {
+        element_type sign;
+
+        if (bareiss(rows, n, sign) < n) {
+            throw std::domain_error("singular matrix in linear system");
+        }
+
+        /*
+         * the last pivot is the determinant of the (row-permuted)
+         * matrix. the numerators are found by fraction-free back
+         * substitution, in which each division is exact.
+         */
+        den = rows[n - 1][n - 1];
+
+        for (size_type k = 0; k < q; k++) {
+            for (size_type i = n; i-- > 0; ) {
+                wide_type sum = static_cast<wide_type>(den) * rows[i][n + k];
+
+                for (size_type j = i + 1; j < n; j++) {
+                    sum = add(sum,
+                              -static_cast<wide_type>(rows[i][j]) * res(j, k));
+                }
+
+                res(i, k) = narrow(sum / rows[i][i]);
+            }
+        }
+    } else {
+        /*
+         * the numerators are determinants of the matrix with one of
+         * its columns replaced by a column of rhs, so the bound comes
+         * from the augmented rows, but with only one column of rhs.
+         * the values are the determinant followed by the numerators.
+         *
+         * the matrix is singular modulo a prime that divides its
+         * determinant, so such primes are unusable for finding the
+         * numerators. once enough primes divide the determinant,
+         * the matrix is singular (see recover()).
+         */
+        std::vector<element_type> vals;
+
+        if (!recover(method, hadamard(rows, n), hadamard(), 1 + n * q,
+                     n * (n + q) * (n + 3) / 3,
+                     [&rows, n, q]
+                     (const residue_type p, std::vector<residue_type> & val)
+                     {
+                         std::vector<std::vector<residue_type>> res =
+                             residues(rows, p);
+                         std::vector<residue_type> inv(n);
+                         residue_type * const sol = &val[1];
+
+                         if (eliminate(res, n, p, val[0]) < n) {
+                             return false;
+                         }
+
+                         for (size_type i = 0; i < n; i++) {
+                             inv[i] = power(res[i][i], p - 2, p);
+                         }
+
+                         for (size_type k = 0; k < q; k++) {
+                             for (size_type i = n; i-- > 0; ) {
+                                 residue_type sum = res[i][n + k];
+
+                                 for (size_type j = i + 1; j < n; j++) {
+                                     sum = (sum + (p - res[i][j]) *
+                                            sol[j * q + k]) % p;
+                                 }
+
+                                 sol[i * q + k] = sum * inv[i] % p;
+                             }
+                         }
+
+                         /* the numerators are the solution times det */
+                         for (size_type j = 0; j < n * q; j++) {
+                             sol[j] = sol[j] * val[0] % p;
+                         }
+
+                         return true;
+                     },
+                     vals)) {
+            throw std::domain_error("singular matrix in linear system");
+        }
+
+        den = vals[0];
+
+        for (size_type j = 0; j < n * q; j++) {
+            res(j / q, j % q) = vals[1 + j];
+        }
+    }
+
+    /* make the denominator positive */
+    if (den < 0) {
+        den = -den;
+        res *= -1;
+    }
+
+    return std::make_pair(res, den);
+}
+
+/*
+ * reduce the elements of the matrix, dividing
+ * the work among threads for large matrices
+ */
+template <typename T>
+template <typename R>
+R matrix<T>::reduce(
+    const R & init,
+    const std::function<void(R &, const element_type *,
+                             size_type, size_type)> & kernel,
+    const std::function<void(R &, const R &)> & combine) const
+{
+    const size_type vectors = _elements.size();
+    const size_type length = vectors ? _elements[0].size() : 0;
+
+    size_type threads = std::thread::hardware_concurrency();
+    size_type t;
+
+    /*
+     * divide the vectors into at most one range per thread, without
+     * splitting individual vectors. parallel() decides whether there's
+     * enough work in the ranges to make more than one thread worthwhile.
+     */
+    threads = std::max<size_type>(std::min(threads, vectors), 1);
+
+    std::vector<R> res(threads, init);
+
+    /*
+     * reduce the t'th range of vectors. the
+     * ranges are as close to equal as possible.
+     */
+    parallel(
+        threads, vectors * length / threads,
+        [this, &res, &kernel, vectors, length, threads]
+        (const size_type t)
+        {
+            const size_type first = vectors * t / threads;
+            const size_type last = vectors * (t + 1) / threads;
+
+            for (size_type i = first; i < last; i++) {
+                kernel(res[t], _elements[i].data(), length, i);
+            }
+        });
+
+    /*
+     * combine the results pairwise, i.e. 0 and 1, 2 and 3, etc.,
+     * then 0 and 2, 4 and 6, etc., until 0 holds the final result
+     */
+    for (size_type step = 1; step < threads; step *= 2) {
+        for (t = 0; t + step < threads; t += 2 * step) {
+            combine(res[t], res[t + step]);
+        }
+    }
+
+    return res[0];
+}
+
+/* perform independent tasks in parallel */
+template <typename T>
+void matrix<T>::parallel(const size_type tasks, const size_type cost,
+                         const std::function<void(size_type)> & work)
+{
+    /*
+     * the minimum number of operations that each thread should
+     * perform. below this, the cost of starting the thread
+     * outweighs the benefit of running in parallel.
+     */
+    const size_type grain = 1 << 16;
+
+    size_type threads = std::thread::hardware_concurrency();
+    size_type t;
+
+    threads = std::min(threads, tasks);
+    threads = std::min(threads, tasks * cost / grain);
+    threads = std::max<size_type>(threads, 1);
+
+    std::vector<std::thread> pool;
+    std::vector<std::exception_ptr> errors(threads);
+
+    /*
+     * reserve the space up front, so that adding a thread to the pool
+     * can't fail (and leave a running thread that can't be joined)
+     */
+    pool.reserve(threads);
+
+    /*
+     * the t'th thread performs every t'th task. exceptions
+     * can't cross threads, so they're stored and rethrown
+     * by the calling thread.
+     */
+    const std::function<void(size_type)> share =
+        [&work, &errors, tasks, threads]
+        (const size_type t)
+        {
+            try {
+                for (size_type i = t; i < tasks; i += threads) {
+                    work(i);
+                }
+            } catch (...) {
+                errors[t] = std::current_exception();
+            }
+        };
+
+    /*
+     * the calling thread takes the first share. if a thread
+     * can't be started, its share is done here, too.
+     */
+    for (t = 1; t < threads; t++) {
+        try {
+            pool.push_back(std::thread(share, t));
+        } catch (const std::system_error &) {
+            share(t);
+        }
+    }
+
+    share(0);
+
+    for (t = 0; t < pool.size(); t++) {
+        pool[t].join();
+    }
+
+    for (t = 0; t < threads; t++) {
+        if (errors[t]) {
+            std::rethrow_exception(errors[t]);
+        }
+    }
+}
+
+/*
+ * the kernels below all keep four independent accumulators. this
+ * breaks the dependency of each operation on the previous one and
+ * allows the compiler to vectorize the loops.
+ */
+
+/* sum a contiguous range of elements */
+template <typename T>
+T matrix<T>::sum(const element_type * const elements, const size_type count)
+{
+    element_type acc[4] = { 0, 0, 0, 0 };
+    size_type i;
+
+    for (i = 0; i + 4 <= count; i += 4) {
+        acc[0] += elements[i + 0];
+        acc[1] += elements[i + 1];
+        acc[2] += elements[i + 2];
+        acc[3] += elements[i + 3];
+    }
+
+    for (; i < count; i++) {
+        acc[0] += elements[i];
+    }
+
+    return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+}
+
+/* sum the absolute values of a contiguous range of elements */
+template <typename T>
+T matrix<T>::abs_sum(const element_type * const elements,
+                     const size_type count)
+{
+    /*
+     * comparing with a variable rather than a literal zero keeps the
+     * compiler from warning that the comparison is always false when
+     * the elements are unsigned; they're used as they are
+     */
+    const element_type zero = 0;
+    element_type acc[4] = { 0, 0, 0, 0 };
+    size_type i, k;
+
+    for (i = 0; i + 4 <= count; i += 4) {
+        for (k = 0; k < 4; k++) {
+            const element_type v = elements[i + k];
+            acc[k] += (v < zero) ? -v : v;
+        }
+    }
+
+    for (; i < count; i++) {
+        const element_type v = elements[i];
+        acc[0] += (v < zero) ? -v : v;
+    }
+
+    return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+}
+
+/* find the smallest of a contiguous range of elements */
+template <typename T>
+T matrix<T>::min(const element_type * const elements, const size_type count)
+{
+    element_type acc[4] = {
+        elements[0], elements[0], elements[0], elements[0]
+    };
+    size_type i;
+
+    for (i = 0; i + 4 <= count; i += 4) {
+        acc[0] = std::min(acc[0], elements[i + 0]);
+        acc[1] = std::min(acc[1], elements[i + 1]);
+        acc[2] = std::min(acc[2], elements[i + 2]);
+        acc[3] = std::min(acc[3], elements[i + 3]);
+    }
+
+    for (; i < count; i++) {
+        acc[0] = std::min(acc[0], elements[i]);
+    }
+
+    return std::min(std::min(acc[0], acc[1]), std::min(acc[2], acc[3]));
+}
+
+/* find the largest of a contiguous range of elements */
+template <typename T>
+T matrix<T>::max(const element_type * const elements, const size_type count)
+{
+    element_type acc[4] = {
+        elements[0], elements[0], elements[0], elements[0]
+    };
+    size_type i;
+
+    for (i = 0; i + 4 <= count; i += 4) {
+        acc[0] = std::max(acc[0], elements[i + 0]);
+        acc[1] = std::max(acc[1], elements[i + 1]);
+        acc[2] = std::max(acc[2], elements[i + 2]);
+        acc[3] = std::max(acc[3], elements[i + 3]);
+    }
+
+    for (; i < count; i++) {
+        acc[0] = std::max(acc[0], elements[i]);
+    }
+
+    return std::max(std::max(acc[0], acc[1]), std::max(acc[2], acc[3]));
+}
+
+/*
+ * the finalizer from the splitmix64 generator,
+ * used to scatter the bits of each input
+ */
+template <typename T>
+std::uint64_t matrix<T>::mix(std::uint64_t x)
+{
+    x = (x ^ (x >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+    x = (x ^ (x >> 27)) * UINT64_C(0x94d049bb133111eb);
+    return x ^ (x >> 31);
+}
+
+/* find the location of the smallest or largest element */
+template <typename T>
+std::pair<typename matrix<T>::size_type,
+          typename matrix<T>::size_type>
+matrix<T>::argextreme(const bool largest) const
+{
+    typedef std::pair<size_type, size_type> location_type;
+    typedef std::pair<element_type, location_type> result_type;
+
+    if (empty()) {
+        throw std::domain_error("empty matrix has no extreme values");
+    }
+
+    /*
+     * returns true if the first value/location should be
+     * chosen over the second. ties in value go to the first
+     * location in row-by-row order, regardless of how the
+     * elements are stored.
+     */
+    const std::function<bool(const result_type &,
+                             const result_type &)> better =
+        [largest]
+        (const result_type & a, const result_type & b)
+        {
+            if (a.first != b.first) {
+                return largest ? (a.first > b.first) : (a.first < b.first);
+            }
+
+            return a.second < b.second;
+        };
+
+    const order_type order = _order;
+
+    return reduce<result_type>(
+        std::make_pair(_elements[0][0], location_type(0, 0)),
+        [&better, largest, order]
+        (result_type & res,
+         const element_type * const elements,
+         const size_type count,
+         const size_type vec)
+        {
+            /*
+             * find the extreme value with the vectorizable kernel
+             * first, then make a second pass to find where it is,
+             * but only if it's a candidate for the result
+             */
+            const element_type val =
+                largest ? max(elements, count) : min(elements, count);
+
+            if (val == res.first || better(result_type(val, res.second),
+                                           res)) {
+                const size_type i =
+                    std::find(elements, elements + count, val) - elements;
+                const result_type cand(
+                    val,
+                    (order == ROWS) ?
+                    location_type(vec, i) : location_type(i, vec));
+
+                if (better(cand, res)) {
+                    res = cand;
+                }
+            }
+        },
+        [&better]
+        (result_type & res, const result_type & other)
+        {
+            if (better(other, res)) {
+                res = other;
+            }
+        }).second;
+}
+
+/* largest absolute sum of any row or column */
+template <typename T>
+T matrix<T>::norm(const order_type order) const
+{
+    if (empty()) {
+        return 0;
+    }
+
+    /*
+     * if the sums are taken along the vectors in which the
+     * elements are stored, each vector is summed separately
+     */
+    if (order == _order) {
+        return reduce<element_type>(
+            0,
+            []
+            (element_type & res,
+             const element_type * const elements,
+             const size_type count,
+             const size_type /* ignored */)
+            {
+                res = std::max(res, abs_sum(elements, count));
+            },
+            []
+            (element_type & res, const element_type & other)
+            {
+                res = std::max(res, other);
+            });
+    }
+
+    /*
+     * otherwise, the sums are taken across the vectors. each range
+     * accumulates its own partial sums, which are then added together.
+     */
+    const std::vector<element_type> sums = reduce<std::vector<element_type>>(
+        std::vector<element_type>(_elements[0].size(), 0),
+        []
+        (std::vector<element_type> & res,
+         const element_type * const elements,
+         const size_type count,
+         const size_type /* ignored */)
+        {
+            const element_type zero = 0;
+
+            for (size_type i = 0; i < count; i++) {
+                const element_type v = elements[i];
+                res[i] += (v < zero) ? -v : v;
+            }
+        },
+        []
+        (std::vector<element_type> & res,
+         const std::vector<element_type> & other)
+        {
+            for (size_type i = 0; i < res.size(); i++) {
+                res[i] += other[i];
+            }
+        });
+
+    return max(sums.data(), sums.size());
+}
+
+/* get the rows of the matrix or of its transposition */
+template <typename T>
+std::vector<std::vector<T>> matrix<T>::vectors(const order_type order) const
+{
+    if (order == _order || empty()) {
+        return _elements;
+    }
+
+    std::vector<std::vector<element_type>> res(
+        _elements[0].size(), std::vector<element_type>(_elements.size()));
+
+    for (size_type i = 0; i < _elements.size(); i++) {
+        for (size_type j = 0; j < _elements[i].size(); j++) {
+            res[j][i] = _elements[i][j];
+        }
+    }
+
+    return res;
+}
+
+/*
+ * convert a wide value to the element type. the most negative value
+ * is excluded so that every value can be negated and so that the
+ * difference of two products of elements always fits in wide_type.
+ */
+template <typename T>
+T matrix<T>::narrow(const wide_type val)
+{
+    const wide_type lim = std::numeric_limits<element_type>::max();
+
+    if (val > lim || val < -lim) {
+        throw std::overflow_error(
+            "result of exact elimination exceeds the range of the elements");
+    }
+
+    return static_cast<element_type>(val);
+}
+
+/* add two wide values */
+template <typename T>
+typename matrix<T>::wide_type matrix<T>::add(const wide_type lhs,
+                                             const wide_type rhs)
+{
+    static_assert(sizeof(wide_type) >= 2 * sizeof(element_type),
+                  "no integral type is wide enough for exact elimination");
+
+    /*
+     * the largest magnitude permitted is the square of the
+     * largest element, so the sum of two such values can't
+     * overflow, but the result must be checked
+     */
+    const wide_type lim =
+        static_cast<wide_type>(std::numeric_limits<element_type>::max()) *
+        std::numeric_limits<element_type>::max();
+    const wide_type sum = lhs + rhs;
+
+    if (sum > lim || sum < -lim) {
+        throw std::overflow_error(
+            "intermediate value of exact elimination is too large");
+    }
+
+    return sum;
+}
+
+/* fraction-free elimination */
+template <typename T>
+typename matrix<T>::size_type
+matrix<T>::bareiss(std::vector<std::vector<element_type>> & rows,
+                   const size_type cols, element_type & sign)
+{
+    static_assert(sizeof(wide_type) >= 2 * sizeof(element_type),
+                  "no integral type is wide enough for exact elimination");
+
+    const size_type m = rows.size();
+    wide_type prev = 1;
+    size_type rank = 0;
+
+    sign = 1;
+
+    for (size_type c = 0; c < cols && rank < m; c++) {
+        size_type r;
+
+        /* find a row with a non-zero element in this column */
+        for (r = rank; r < m && rows[r][c] == 0; r++) {
+        }
+
+        if (r == m) {
+            continue;
+        }
+
+        /* swapping the vectors just exchanges their storage */
+        if (r != rank) {
+            std::swap(rows[r], rows[rank]);
+            sign = -sign;
+        }
+
+        const element_type * const pr = rows[rank].data();
+        const size_type len = rows[rank].size();
+        const wide_type piv = pr[c];
+
+        /*
+         * every row below the pivot is replaced by the determinant
+         * of the 2x2 matrix formed with the pivot row, divided by
+         * the previous pivot. the division is always exact. each
+         * row is streamed through once, against the pivot row.
+         */
+        for (size_type i = rank + 1; i < m; i++) {
+            element_type * const ri = rows[i].data();
+            const wide_type f = ri[c];
+
+            if (prev == 1) {
+                for (size_type j = c + 1; j < len; j++) {
+                    ri[j] = narrow(piv * ri[j] - f * pr[j]);
+                }
+            } else {
+                for (size_type j = c + 1; j < len; j++) {
+                    ri[j] = narrow((piv * ri[j] - f * pr[j]) / prev);
+                }
+            }
+
+            ri[c] = 0;
+        }
+
+        prev = piv;
+        rank++;
+    }
+
+    return rank;
+}
+
+/* logarithms of the lengths of a set of rows */
+template <typename T>
+std::vector<double>
+matrix<T>::lengths(const std::vector<std::vector<element_type>> & rows,
+                   const size_type cols)
+{
+    std::vector<double> res(rows.size());
+
+    for (size_type i = 0; i < rows.size(); i++) {
+        double sum = 0, alt = 0;
+
+        for (size_type j = 0; j < rows[i].size(); j++) {
+            const double v = static_cast<double>(rows[i][j]);
+
+            if (j < cols) {
+                sum += v * v;
+            } else {
+                alt = std::max(alt, v * v);
+            }
+        }
+
+        res[i] = std::log2(std::max(sum + alt, 1.0)) / 2;
+    }
+
+    return res;
+}
+
+/* logarithm of the hadamard bound */
+template <typename T>
+double matrix<T>::hadamard(const std::vector<std::vector<element_type>> & rows,
+                           const size_type cols)
+{
+    const std::vector<double> len = lengths(rows, cols);
+    double bits = 0;
+
+    for (size_type i = 0; i < len.size(); i++) {
+        bits += len[i];
+    }
+
+    return bits;
+}
+
+/* logarithm of the hadamard bound of the matrix */
+template <typename T>
+double matrix<T>::hadamard(void) const
+{
+    const size_type len = empty() ? 0 : _elements[0].size();
+    const order_type other = (_order == ROWS) ? COLS : ROWS;
+
+    /*
+     * the bound applies equally to the transposition, and either
+     * one can be much smaller than the other for a matrix that
+     * has a few large elements in the same row or column
+     */
+    return std::min(hadamard(_elements, len),
+                    hadamard(vectors(other), _elements.size()));
+}
+
+/* number of primes required for modular elimination */
+template <typename T>
+typename matrix<T>::size_type matrix<T>::moduli(double bits)
+{
+    /*
+     * the product of the primes must exceed twice the bound, i.e.
+     * one more bit. each prime provides almost 31 bits; count it as
+     * 30 to allow for rounding in the calculation of the bound.
+     */
+    bits += 1;
+
+    return static_cast<size_type>(std::ceil(bits / 30));
+}
+
+/* number of random primes required to confirm a result */
+template <typename T>
+typename matrix<T>::size_type matrix<T>::confirmations(const double bits)
+{
+    /*
+     * a non-zero value less than 2^(bits + 1) in magnitude, such as the
+     * difference between an incorrect result and the correct one, has
+     * at most moduli(bits) prime factors greater than 2^30. there are
+     * more than 2^25 primes between 2^30 and 2^31, so the probability
+     * that a random one of them is a factor is less than 2^-odds.
+     */
+    const size_type full = moduli(bits);
+    const double odds = 25 - std::log2(static_cast<double>(full));
+
+    /*
+     * a single call may check as many results as there are primes
+     * (or, for a rank, rows), so each check is made with a margin
+     * of 2^-16 to keep the probability of any error below 2^-64
+     */
+    if (odds < 1) {
+        return full;
+    }
+
+    return std::min(full, static_cast<size_type>(std::ceil(80 / odds)));
+}
+
+/* primality by trial division */
+template <typename T>
+bool matrix<T>::prime(const residue_type c)
+{
+    residue_type d;
+
+    if (c % 2 == 0) {
+        return c == 2;
+    }
+
+    for (d = 3; d * d <= c && c % d != 0; d += 2) {
+    }
+
+    return d * d > c;
+}
+
+/* primes that haven't been used yet */
+template <typename T>
+std::vector<typename matrix<T>::residue_type>
+matrix<T>::primes(const size_type count, const elimination_type method,
+                  std::vector<residue_type> & used)
+{
+    std::vector<residue_type> res;
+
+    if (method == RANDOMIZED) {
+        /*
+         * about one in 21 odd numbers in the range is prime, and the
+         * chance of picking one that has already been used is tiny
+         */
+        std::mt19937_64 engine(std::random_device{}());
+        std::uniform_int_distribution<residue_type> pick(
+            UINT64_C(1) << 29, (UINT64_C(1) << 30) - 1);
+
+        while (res.size() < count) {
+            const residue_type c = 2 * pick(engine) + 1;
+
+            if (prime(c) &&
+                std::find(used.begin(), used.end(), c) == used.end() &&
+                std::find(res.begin(), res.end(), c) == res.end()) {
+                res.push_back(c);
+            }
+        }
+    } else {
+        /*
+         * primes are dense enough near 2^31 that simple trial
+         * division finds the thousands required quickly. the
+         * primes used so far are in descending order.
+         */
+        residue_type c = used.empty() ? (UINT64_C(1) << 31) - 1 :
+            used.back() - 2;
+
+        for (; res.size() < count; c -= 2) {
+            if (prime(c)) {
+                res.push_back(c);
+            }
+        }
+    }
+
+    used.insert(used.end(), res.begin(), res.end());
+
+    return res;
+}
+
+/* find values from their residues modulo enough primes */
+template <typename T>
+bool matrix<T>::recover(
+    const elimination_type method, const double bits, const double singular,
+    const size_type count, const size_type cost,
+    const std::function<bool(residue_type,
+                             std::vector<residue_type> &)> & residues,
+    std::vector<element_type> & values)
+{
+    /*
+     * full is the number of primes that proves the values. start is
+     * just enough to cover the range of the elements: with that many,
+     * a value that appears to be out of range certainly is.
+     */
+    const size_type full = moduli(bits);
+    const size_type start =
+        std::min(full, moduli(std::numeric_limits<element_type>::digits));
+
+    /*
+     * a non-zero determinant isn't divisible by enough primes for
+     * their product to exceed it, and is very unlikely to be divisible
+     * by a number of random primes, so that many unusable primes show
+     * that it's zero
+     */
+    const size_type limit = (method == MODULAR) ?
+        moduli(singular) : confirmations(singular);
+
+    /* the residues of the j'th value modulo each of the primes in p */
+    std::vector<std::vector<residue_type>> res(count);
+    std::vector<residue_type> p, used;
+    std::vector<element_type> prev;
+
+    size_type unusable = 0, want = start;
+
+    for (;;) {
+        /*
+         * try enough new primes to bring the number of usable ones up
+         * to the number wanted, all at once, and then try again if
+         * any of them turn out to be unusable
+         */
+        while (p.size() < want) {
+            const std::vector<residue_type> batch =
+                primes(want - p.size(), method, used);
+            std::vector<std::vector<residue_type>> more(
+                batch.size(), std::vector<residue_type>(count));
+            std::vector<char> usable(batch.size());
+
+            parallel(
+                batch.size(), cost,
+                [&residues, &batch, &more, &usable]
+                (const size_type i)
+                {
+                    usable[i] = residues(batch[i], more[i]);
+                });
+
+            for (size_type i = 0; i < batch.size(); i++) {
+                if (!usable[i]) {
+                    unusable++;
+                    continue;
+                }
+
+                p.push_back(batch[i]);
+
+                for (size_type j = 0; j < count; j++) {
+                    res[j].push_back(more[i][j]);
+                }
+            }
+
+            /*
+             * a single usable prime shows that the determinant
+             * isn't zero, no matter how many others weren't
+             */
+            if (p.empty() && unusable >= limit) {
+                return false;
+            }
+        }
+
+        values.resize(count);
+
+        for (size_type j = 0; j < count; j++) {
+            values[j] = reconstruct(res[j], p);
+        }
+
+        if (p.size() >= full) {
+            return true;
+        }
+
+        /*
+         * with random primes, the values are accepted once they're
+         * unchanged by the addition of enough of them. otherwise,
+         * the values are in range, but only the rest of the primes
+         * can show whether they're correct.
+         */
+        if (method == RANDOMIZED) {
+            if (values == prev) {
+                return true;
+            }
+
+            prev = values;
+            want = std::min(full, p.size() + confirmations(bits));
+        } else {
+            want = full;
+        }
+    }
+}
+
+/* modular exponentiation */
+template <typename T>
+typename matrix<T>::residue_type
+matrix<T>::power(residue_type base, residue_type exp, const residue_type p)
+{
+    residue_type res = 1;
+
+    for (base %= p; exp; exp >>= 1) {
+        if (exp & 1) {
+            res = res * base % p;
+        }
+
+        base = base * base % p;
+    }
+
+    return res;
+}
+
+/* gaussian elimination modulo a prime */
+template <typename T>
+typename matrix<T>::size_type
+matrix<T>::eliminate(std::vector<std::vector<residue_type>> & rows,
+                     const size_type cols, const residue_type p,
+                     residue_type & det)
+{
+    /*
+     * the number of pivots whose updates to the remaining
+     * rows are delayed and then applied together
+     */
+    const size_type block = 32;
+
+    /*
+     * elements are reduced lazily: each update adds a product of two
+     * residues, less than 2^62, and a multiple of p is subtracted only
+     * once the element reaches 2^63. the subtraction is selected using
+     * the top bit rather than a branch, and the division is kept out of
+     * the innermost loops, so that the compiler is able to vectorize them.
+     * elements are fully reduced only when they're needed as pivots.
+     */
+    const residue_type mult = (UINT64_C(1) << 62) / p * p + p;
+
+    const size_type m = rows.size();
+    const size_type len = m ? rows[0].size() : 0;
+    size_type rank = 0, c = 0;
+
+    /*
+     * the pivot rows of the current block, and the multiples of each
+     * of them that have yet to be added to each of the remaining rows
+     */
+    std::vector<const residue_type *> pivots(block);
+    std::vector<residue_type> mults;
+
+    det = 1;
+
+    while (c < cols && rank < m) {
+        const size_type first = rank;
+        size_type count = 0;
+        size_type i, j, t;
+
+        mults.assign((m - first) * block, 0);
+
+        /*
+         * find the pivots for this block. only the elements
+         * needed to find them are brought up to date.
+         */
+        for (; c < cols && rank < m && count < block; c++) {
+            size_type r = m;
+
+            /*
+             * bring this column up to date, and find
+             * a row with a non-zero element in it
+             */
+            for (i = rank; i < m; i++) {
+                residue_type & e = rows[i][c];
+                const residue_type * const g = &mults[(i - first) * block];
+
+                for (t = 0; t < count; t++) {
+                    const residue_type v = e + g[t] * pivots[t][c];
+                    e = v - (mult & (0 - (v >> 63)));
+                }
+
+                e %= p;
+
+                if (r == m && e != 0) {
+                    r = i;
+                }
+            }
+
+            if (r == m) {
+                continue;
+            }
+
+            /* swapping the vectors just exchanges their storage */
+            if (r != rank) {
+                std::swap(rows[r], rows[rank]);
+                std::swap_ranges(mults.begin() + (r - first) * block,
+                                 mults.begin() + (r - first + 1) * block,
+                                 mults.begin() + (rank - first) * block);
+                det = (p - det) % p;
+            }
+
+            residue_type * const pr = rows[rank].data();
+            const residue_type * const g = &mults[(rank - first) * block];
+
+            /* bring the remainder of the pivot row up to date */
+            for (t = 0; t < count; t++) {
+                const residue_type gt = g[t];
+                const residue_type * const pt = pivots[t];
+
+                if (gt != 0) {
+                    for (j = c + 1; j < len; j++) {
+                        const residue_type v = pr[j] + gt * pt[j];
+                        pr[j] = v - (mult & (0 - (v >> 63)));
+                    }
+                }
+            }
+
+            for (j = c + 1; j < len; j++) {
+                pr[j] %= p;
+            }
+
+            const residue_type inv = power(pr[c], p - 2, p);
+
+            det = det * pr[c] % p;
+
+            /*
+             * record the multiple of the pivot row that eliminates
+             * this column from each of the rows below it
+             */
+            for (i = rank + 1; i < m; i++) {
+                residue_type & e = rows[i][c];
+
+                if (e != 0) {
+                    mults[(i - first) * block + count] = p - e * inv % p;
+                    e = 0;
+                }
+            }
+
+            pivots[count++] = pr;
+            rank++;
+        }
+
+        /*
+         * the columns up to c are now up to date in every row. apply
+         * the pivots to the rest of each remaining row, all at once,
+         * while the row is in cache.
+         */
+        for (i = rank; i < m; i++) {
+            residue_type * const ri = rows[i].data();
+            const residue_type * const g = &mults[(i - first) * block];
+
+            for (t = 0; t < count; t++) {
+                const residue_type gt = g[t];
+                const residue_type * const pt = pivots[t];
+
+                if (gt != 0) {
+                    for (j = c; j < len; j++) {
+                        const residue_type v = ri[j] + gt * pt[j];
+                        ri[j] = v - (mult & (0 - (v >> 63)));
+                    }
+                }
+            }
+        }
+    }
+
+    /* det is only the determinant if the pivots are on the diagonal */
+    if (rank < cols) {
+        det = 0;
+    }
+
+    return rank;
+}
+
+/* reduce rows modulo a prime */
+template <typename T>
+std::vector<std::vector<typename matrix<T>::residue_type>>
+matrix<T>::residues(const std::vector<std::vector<element_type>> & rows,
+                    const residue_type p)
+{
+    std::vector<std::vector<residue_type>> res(rows.size());
+
+    for (size_type i = 0; i < rows.size(); i++) {
+        res[i].resize(rows[i].size());
+
+        for (size_type j = 0; j < rows[i].size(); j++) {
+            wide_type r = static_cast<wide_type>(rows[i][j]) %
+                static_cast<wide_type>(p);
+
+            if (r < 0) {
+                r += p;
+            }
+
+            res[i][j] = static_cast<residue_type>(r);
+        }
+    }
+
+    return res;
+}
+
+/* chinese remainder reconstruction */
+template <typename T>
+T matrix<T>::reconstruct(const std::vector<residue_type> & res,
+                         const std::vector<residue_type> & p)
+{
+    const size_type k = res.size();
+    std::vector<long long> v(k);
+
+    /*
+     * use garner's algorithm to find the digits of the value in
+     * the mixed radix p[0], p[0] * p[1], ..., choosing each digit
+     * from (-p[i] / 2, p[i] / 2] so that the value is the one with
+     * the smallest magnitude
+     */
+    for (size_type i = 0; i < k; i++) {
+        const long long pi = p[i];
+        residue_type sum = 0, prod = 1, d;
+
+        for (size_type j = 0; j < i; j++) {
+            sum = (sum + static_cast<residue_type>((v[j] % pi + pi) % pi) *
+                   prod) % p[i];
+            prod = prod * p[j] % p[i];
+        }
+
+        d = (res[i] + p[i] - sum) % p[i] * power(prod, p[i] - 2, p[i]) % p[i];
+        v[i] = (d > p[i] / 2) ? static_cast<long long>(d) - pi : d;
+    }
+
+    /*
+     * evaluate the digits from the most significant. the magnitude of
+     * the final value is at least that of the partial value, less one
+     * half, so once the partial value is out of range, it stays that way.
+     */
+    const wide_type lim = std::numeric_limits<element_type>::max();
+    wide_type val = 0;
+
+    for (size_type i = k; i-- > 0; ) {
+        val = val * static_cast<wide_type>(p[i]) + v[i];
+
+        if (val > lim || val < -lim) {
+            break;
+        }
+    }
+
+    return narrow(val);
+}
+
 /*
  * local variables:
  * mode: c++
@@ -0,0 +1,289 @@
+/*
+ * see matrix.h for an explanation of
+ * the use of #pragma once
+ */
+#pragma once
+
+#include "matrix.h"
+
+#include <vector>
+#include <cstddef>
+
+/*!
+ * @brief A product of two matrices that is kept up to date as
+ *        the factors are modified
+ *
+ * The object owns copies of two matrices, `A` and `B`, and the product
+ * `C = A * B`. Writes to the factors made through the lhs() and rhs()
+ * objects are recorded by row of `A` and by column of `B`, and when the
+ * product is next requested, only the changed entries are applied to
+ * it: a change to `A(i, k)` is an update of row `i` of `C` and a change
+ * to `B(k, j)` is an update of column `j` of `C`. If enough of the
+ * factors have changed that the updates would cost more than a full
+ * multiplication, the product is simply recomputed.
+ */
+template <typename T>
+class tracked_product
+{
+public:
+    /*!
+     * @brief The type of the elements contained in the matrices
+     */
+    typedef T element_type;
+    /*!
+     * @brief An unsigned type used to index elements in the matrices
+     */
+    typedef std::size_t size_type;
+
+    /*!
+     * @brief One of the two factors of a tracked product
+     *
+     * An operand provides the same element access as a matrix,
+     * but records the location and original value of every
+     * element that may have been written, until so many have
+     * been written that the product must be recomputed.
+     */
+    class operand
+    {
+    public:
+        /*!
+         * @brief Access an element at a specific row and column
+         *
+         * The element is recorded as (potentially) changed. No
+         * bounds checking is performed on the access.
+         *
+         * @note The returned reference should not be written through
+         *       after the next call to tracked_product::result() or
+         *       tracked_product::update(), as such writes would not
+         *       be tracked.
+         *
+         * @see matrix::operator()(size_type, size_type)
+         */
+        element_type & operator ()(size_type row, size_type col);
+        /*!
+         * @brief Access an element of a `const` operand
+         *
+         * @see matrix::operator()(size_type, size_type) const
+         */
+        const element_type & operator ()(size_type row, size_type col) const;
+
+        /*!
+         * @brief Access an element at a specific row and column
+         *
+         * The element is recorded as (potentially) changed. If `row`
+         * or `col` is out of range, `std::out_of_range` is thrown.
+         *
+         * @see operator()(size_type, size_type)
+         * @see matrix::at(size_type, size_type)
+         */
+        element_type & at(size_type row, size_type col);
+        /*!
+         * @brief Access an element of a `const` operand
+         *
+         * @see matrix::at(size_type, size_type) const
+         */
+        const element_type & at(size_type row, size_type col) const;
+
+        /*!
+         * @brief Transform each element in the operand
+         *
+         * Only those elements whose values are actually
+         * changed by the transformation are recorded.
+         *
+         * @see matrix::transform()
+         */
+        void transform(const std::function<element_type(size_type, size_type,
+                                                        element_type)> & xfrm);
+
+        /*!
+         * @brief Get the number of rows and columns in the operand
+         *
+         * @see matrix::size()
+         */
+        std::pair<size_type, size_type> size(void) const;
+
+        /*!
+         * @brief Get the current value of the operand
+         */
+        const matrix<element_type> & value(void) const;
+
+    private:
+        friend class tracked_product<element_type>;
+
+        /*!
+         * @brief Construct an operand with the given initial value
+         *
+         * @param[in] m The initial value of the operand
+         * @param[in] rows `true` if changes are tracked by row (the
+         *                 left-hand factor), or `false` if they're
+         *                 tracked by column (the right-hand factor)
+         */
+        operand(const matrix<element_type> & m, bool rows);
+
+        /*!
+         * @brief Record an element as changed
+         *
+         * The first time that an element in a row (or column) is
+         * recorded, the entire row (or column) is saved. These are
+         * the values that were used to compute the product.
+         */
+        void touch(size_type row, size_type col);
+
+        /*!
+         * @brief Set the density of changes at which tracking stops
+         *
+         * Once the fraction of the elements that have changed reaches the
+         * threshold, the product will have to be recomputed no matter what
+         * happens to the other operand, so the changes are forgotten and
+         * no more are recorded until after the next update.
+         */
+        void threshold(double t);
+
+        /*!
+         * @brief Forget all recorded changes
+         */
+        void clear(void);
+
+        /*!
+         * @brief The current value of the operand
+         */
+        matrix<element_type> _value;
+        /*!
+         * @brief Whether changes are tracked by row or by column
+         */
+        bool _rows;
+        /*!
+         * @brief The original values of each row (or column) that has
+         *        changed since the product was last updated
+         *
+         * The vector for a row (or column) that hasn't changed is empty.
+         */
+        std::vector<std::vector<element_type>> _saved;
+        /*!
+         * @brief Flags denoting which elements of each
+         *        saved row (or column) have changed
+         */
+        std::vector<std::vector<bool>> _changed;
+        /*!
+         * @brief The indicies of the rows (or columns) that have changed
+         */
+        std::vector<size_type> _dirty;
+        /*!
+         * @brief The number of elements that have changed
+         */
+        size_type _count;
+        /*!
+         * @brief The number of changed elements at which tracking stops
+         */
+        double _limit;
+        /*!
+         * @brief Whether tracking has stopped, in which
+         *        case the product must be recomputed
+         */
+        bool _stale;
+    };
+
+    /*!
+     * @brief Construct the product of two matrices
+     *
+     * If the two matrices are not dimensionally compatible for
+     * multiplication, std::domain_error will be thrown.
+     *
+     * @param[in] lhs The left-hand factor, `A`
+     * @param[in] rhs The right-hand factor, `B`
+     *
+     * @see matrix::multiply(const matrix<element_type> &) const
+     */
+    tracked_product(const matrix<element_type> & lhs,
+                    const matrix<element_type> & rhs);
+
+    /*!
+     * @brief Access the left-hand factor, `A`
+     */
+    operand & lhs(void);
+    /*!
+     * @brief Access the left-hand factor, `A`, of a `const` product
+     */
+    const operand & lhs(void) const;
+
+    /*!
+     * @brief Access the right-hand factor, `B`
+     */
+    operand & rhs(void);
+    /*!
+     * @brief Access the right-hand factor, `B`, of a `const` product
+     */
+    const operand & rhs(void) const;
+
+    /*!
+     * @brief Get the product of the two factors
+     *
+     * Any changes to the factors that have not yet been
+     * applied to the product are applied before returning.
+     *
+     * @return The product, `A * B`
+     */
+    const matrix<element_type> & result(void);
+
+    /*!
+     * @brief Apply pending changes in the factors to the product
+     *
+     * Changes are batched until this function (or result()) is called.
+     * Applying a changed element of `A` costs `n` operations and applying
+     * a changed element of `B` costs `m` operations, where the product
+     * is `m x n`. The fraction of a full multiplication that this work
+     * represents is the fraction of `A` that has changed plus the fraction
+     * of `B` that has changed. When that sum reaches threshold(), the
+     * product is recomputed from scratch instead. Once either fraction
+     * alone reaches threshold(), changes to that factor are no longer
+     * recorded.
+     */
+    void update(void);
+
+    /*!
+     * @brief Get the density of changes at which the
+     *        product is fully recomputed
+     *
+     * The default threshold is 0.5.
+     *
+     * @see update()
+     */
+    double threshold(void) const;
+    /*!
+     * @brief Set the density of changes at which the
+     *        product is fully recomputed
+     *
+     * @param[in] t The new threshold. A value of zero causes the product
+     *              to always be recomputed when anything has changed.
+     *
+     * @see update()
+     */
+    void threshold(double t);
+
+private:
+    /*!
+     * @brief The left-hand factor
+     */
+    operand _lhs;
+    /*!
+     * @brief The right-hand factor
+     */
+    operand _rhs;
+    /*!
+     * @brief The product of the factors as of the last update
+     */
+    matrix<element_type> _result;
+    /*!
+     * @brief The density of changes at which the
+     *        product is fully recomputed
+     */
+    double _threshold;
+};
+
+#include "matrix_product.tpp"
+
+/*
+ * local variables:
+ * mode: c++
+ * end:
+ */
@@ -0,0 +1,366 @@
+#pragma once
+
+#include <limits>
+
+/*
+ * construct an operand, with nothing dirty. there is no limit
+ * on the number of changes until the product sets one.
+ */
+template <typename T>
+tracked_product<T>::operand::operand(const matrix<element_type> & m,
+                                     const bool rows)
+    : _value(m), _rows(rows),
+      _saved(rows ? m.size().first : m.size().second),
+      _changed(_saved.size()),
+      _count(0), _limit(std::numeric_limits<double>::infinity()),
+      _stale(false)
+{
+}
+
+/* non-const, unchecked element access */
+template <typename T>
+T & tracked_product<T>::operand::operator ()(const size_type row,
+                                              const size_type col)
+{
+    /*
+     * the caller may write through the returned
+     * reference, so assume that it will
+     */
+    touch(row, col);
+    return _value(row, col);
+}
+
+/* const, unchecked element access */
+template <typename T>
+const T & tracked_product<T>::operand::operator ()(const size_type row,
+                                                    const size_type col) const
+{
+    return _value(row, col);
+}
+
+/* non-const, checked element access */
+template <typename T>
+T & tracked_product<T>::operand::at(const size_type row, const size_type col)
+{
+    /*
+     * get the reference first so that an out of range
+     * element isn't recorded before the exception is thrown
+     */
+    element_type & val = _value.at(row, col);
+    touch(row, col);
+    return val;
+}
+
+/* const, checked element access */
+template <typename T>
+const T & tracked_product<T>::operand::at(const size_type row,
+                                           const size_type col) const
+{
+    return _value.at(row, col);
+}
+
+/* transform each element in the operand */
+template <typename T>
+void tracked_product<T>::operand::transform(
+    const std::function<element_type(size_type, size_type,
+                                     element_type)> & xfrm)
+{
+    if (xfrm == nullptr) {
+        return;
+    }
+
+    /*
+     * unlike the element access functions, the new value is
+     * known here, so only record elements that actually change
+     */
+    _value.transform(
+        [this, &xfrm]
+        (const size_type row,
+         const size_type col,
+         const element_type val)
+        {
+            const element_type res = xfrm(row, col, val);
+
+            /*
+             * the elements are visited row by row, so any element of a
+             * row or column visited before this one that was changed has
+             * already caused the row or column to be saved
+             */
+            if (res != val) {
+                touch(row, col);
+            }
+
+            return res;
+        });
+}
+
+/* determine the size of the operand */
+template <typename T>
+std::pair<typename tracked_product<T>::size_type,
+          typename tracked_product<T>::size_type>
+tracked_product<T>::operand::size(void) const
+{
+    return _value.size();
+}
+
+/* get the current value of the operand */
+template <typename T>
+const matrix<T> & tracked_product<T>::operand::value(void) const
+{
+    return _value;
+}
+
+/* record an element as dirty */
+template <typename T>
+void tracked_product<T>::operand::touch(const size_type row,
+                                        const size_type col)
+{
+    if (_stale) {
+        return;
+    }
+
+    /*
+     * the "line" is the row or column in which changes are
+     * tracked, and pos is the position of the element within it
+     */
+    const size_type line = _rows ? row : col;
+    const size_type pos = _rows ? col : row;
+
+    std::vector<element_type> & saved = _saved[line];
+    std::vector<bool> & changed = _changed[line];
+
+    /* save the whole line the first time any element in it changes */
+    if (saved.empty()) {
+        const size_type length =
+            _rows ? _value.size().second : _value.size().first;
+
+        saved.resize(length);
+        for (size_type i = 0; i < length; i++) {
+            saved[i] = _rows ? _value(line, i) : _value(i, line);
+        }
+
+        changed.assign(length, false);
+        _dirty.push_back(line);
+    }
+
+    if (!changed[pos]) {
+        changed[pos] = true;
+        _count++;
+
+        /*
+         * past the limit, the product is going to be
+         * recomputed, so there's no point in keeping track
+         */
+        if (_count >= _limit) {
+            clear();
+            _stale = true;
+        }
+    }
+}
+
+/* set the limit on the number of changes */
+template <typename T>
+void tracked_product<T>::operand::threshold(const double t)
+{
+    const std::pair<size_type, size_type> this_size = _value.size();
+
+    _limit = t * this_size.first * this_size.second;
+
+    if (_count > 0 && _count >= _limit) {
+        clear();
+        _stale = true;
+    }
+}
+
+/* forget all changes */
+template <typename T>
+void tracked_product<T>::operand::clear(void)
+{
+    /* release the memory used by the saved lines */
+    for (size_type i = 0; i < _dirty.size(); i++) {
+        std::vector<element_type>().swap(_saved[_dirty[i]]);
+        std::vector<bool>().swap(_changed[_dirty[i]]);
+    }
+
+    _dirty.clear();
+    _count = 0;
+    _stale = false;
+}
+
+/*
+ * construct the product. the multiplication
+ * checks the dimensions of the factors.
+ */
+template <typename T>
+tracked_product<T>::tracked_product(const matrix<element_type> & lhs,
+                                    const matrix<element_type> & rhs)
+    : _lhs(lhs, true), _rhs(rhs, false), _result(lhs.multiply(rhs)),
+      _threshold(0.5)
+{
+    _lhs.threshold(_threshold);
+    _rhs.threshold(_threshold);
+}
+
+template <typename T>
+typename tracked_product<T>::operand & tracked_product<T>::lhs(void)
+{
+    return _lhs;
+}
+
+template <typename T>
+const typename tracked_product<T>::operand &
+tracked_product<T>::lhs(void) const
+{
+    return _lhs;
+}
+
+template <typename T>
+typename tracked_product<T>::operand & tracked_product<T>::rhs(void)
+{
+    return _rhs;
+}
+
+template <typename T>
+const typename tracked_product<T>::operand &
+tracked_product<T>::rhs(void) const
+{
+    return _rhs;
+}
+
+/* get the up-to-date product */
+template <typename T>
+const matrix<T> & tracked_product<T>::result(void)
+{
+    update();
+    return _result;
+}
+
+/* apply pending changes to the product */
+template <typename T>
+void tracked_product<T>::update(void)
+{
+    const matrix<element_type> & a = _lhs._value;
+    const matrix<element_type> & b = _rhs._value;
+
+    if (!_lhs._stale && !_rhs._stale &&
+        _lhs._dirty.empty() && _rhs._dirty.empty()) {
+        return;
+    }
+
+    /*
+     * m is the number of rows in the product
+     * n is the number of columns in the product
+     * p is the number of columns in a and rows in b
+     *
+     * the factors can't have dirty elements unless
+     * they're non-empty, so none of these are zero
+     */
+    const size_type m = a.size().first;
+    const size_type n = b.size().second;
+    const size_type p = a.size().second;
+
+    /*
+     * the fraction of a full multiplication required to apply
+     * the changes (see the header). a stale operand has stopped
+     * counting, because it has already passed the threshold.
+     */
+    if (_lhs._stale || _rhs._stale ||
+        static_cast<double>(_lhs._count) / (m * p) +
+        static_cast<double>(_rhs._count) / (p * n) >= _threshold) {
+        _result = a.multiply(b);
+    } else {
+        /*
+         * with A' = A + dA and B' = B + dB, the new product is
+         *
+         *   A'B' = AB + A'dB + dA B
+         *
+         * so the changes to b are applied using the new values of a
+         * and the changes to a are applied using the old values of b.
+         */
+        const std::vector<size_type> & rows = _lhs._dirty;
+        const std::vector<size_type> & cols = _rhs._dirty;
+        size_type i, j, k, x;
+
+        /*
+         * a change to b(k, j) changes column j of the
+         * product by column k of a times the difference
+         */
+        for (x = 0; x < cols.size(); x++) {
+            j = cols[x];
+
+            for (k = 0; k < p; k++) {
+                if (!_rhs._changed[j][k]) {
+                    continue;
+                }
+
+                const element_type d = b(k, j) - _rhs._saved[j][k];
+
+                if (d != 0) {
+                    for (i = 0; i < m; i++) {
+                        _result(i, j) += a(i, k) * d;
+                    }
+                }
+            }
+        }
+
+        /*
+         * a change to a(i, k) changes row i of the product by
+         * the (old) row k of b times the difference
+         */
+        for (x = 0; x < rows.size(); x++) {
+            i = rows[x];
+
+            for (k = 0; k < p; k++) {
+                if (!_lhs._changed[i][k]) {
+                    continue;
+                }
+
+                const element_type d = a(i, k) - _lhs._saved[i][k];
+
+                if (d == 0) {
+                    continue;
+                }
+
+                for (j = 0; j < n; j++) {
+                    _result(i, j) += d * b(k, j);
+                }
+
+                /*
+                 * the loop above used the new values of row k of b,
+                 * so back out the changes to the dirty columns of b
+                 */
+                for (size_type y = 0; y < cols.size(); y++) {
+                    j = cols[y];
+
+                    if (_rhs._changed[j][k]) {
+                        _result(i, j) -= d * (b(k, j) - _rhs._saved[j][k]);
+                    }
+                }
+            }
+        }
+    }
+
+    _lhs.clear();
+    _rhs.clear();
+}
+
+template <typename T>
+double tracked_product<T>::threshold(void) const
+{
+    return _threshold;
+}
+
+template <typename T>
+void tracked_product<T>::threshold(const double t)
+{
+    _threshold = t;
+
+    _lhs.threshold(t);
+    _rhs.threshold(t);
+}
+
+/*
+ * local variables:
+ * mode: c++
+ * end:
+ */
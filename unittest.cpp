@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 
 #include "matrix.h"
+#include "matrix_product.h"
 
 static const int TEST_CYCLES = 100;
 
@@ -359,3 +360,509 @@ TEST(matrix, transpose_multiply)
         EXPECT_EQ((a * b).transpose(), b.transpose() * a.transpose());
     }
 }
+
+/*
+ * test that a tracked product stays equal to a freshly
+ * computed product as its factors are modified
+ */
+TEST(matrix, tracked_product)
+{
+    for (int c = 0; c < TEST_CYCLES; c++) {
+        const int rows = 1 + rand() % 20;
+        const int cols = 1 + rand() % 20;
+        const int inner = 1 + rand() % 20;
+
+        matrix<int> a(rows, inner), b(inner, cols);
+
+        /* initialize the factors with small values */
+        a.transform(
+            []
+            (const std::size_t /* ignored */,
+             const std::size_t /* ignored */,
+             const int /* ignored */)
+            {
+                return rand() % 100;
+            });
+        b.transform(
+            []
+            (const std::size_t /* ignored */,
+             const std::size_t /* ignored */,
+             const int /* ignored */)
+            {
+                return rand() % 100;
+            });
+
+        tracked_product<int> p(a, b);
+        EXPECT_EQ(p.result(), a * b);
+
+        /*
+         * alternate between forcing the incremental path,
+         * forcing recomputation, and the default threshold
+         */
+        if (c % 3 == 0) {
+            p.threshold(1e9);
+        } else if (c % 3 == 1) {
+            p.threshold(0);
+        }
+
+        for (int u = 0; u < 10; u++) {
+            /*
+             * make a few changes to each factor through each of
+             * the access functions. some elements may be changed
+             * more than once, and a row of b may be changed along
+             * with the corresponding column of a.
+             */
+            const int k = rand() % inner;
+
+            p.lhs()(rand() % rows, k) = rand() % 100;
+            p.lhs().at(rand() % rows, rand() % inner) += rand() % 100;
+            p.rhs()(k, rand() % cols) = rand() % 100;
+            p.rhs().at(rand() % inner, rand() % cols) -= rand() % 100;
+
+            /* reading through a const operand doesn't dirty anything */
+            const tracked_product<int> & q = p;
+            EXPECT_EQ(q.lhs()(0, 0), q.lhs().at(0, 0));
+
+            if (u % 2) {
+                const std::size_t j = rand() % cols;
+
+                /* change an entire column of b */
+                p.rhs().transform(
+                    [j]
+                    (const std::size_t /* ignored */,
+                     const std::size_t col,
+                     const int val)
+                    {
+                        return col == j ? val + 1 : val;
+                    });
+            }
+
+            if (u == 5) {
+                /*
+                 * change every element of a, which passes any
+                 * threshold less than one and stops the tracking
+                 */
+                p.lhs().transform(
+                    []
+                    (const std::size_t /* ignored */,
+                     const std::size_t /* ignored */,
+                     const int val)
+                    {
+                        return val - 1;
+                    });
+            }
+
+            EXPECT_THROW(p.lhs().at(rows, 0), std::out_of_range);
+
+            EXPECT_EQ(p.result(),
+                      p.lhs().value() * p.rhs().value());
+        }
+    }
+
+    /* incompatible factors can't be multiplied */
+    EXPECT_THROW(tracked_product<int>(matrix<int>(2, 3), matrix<int>(2, 3)),
+                 std::domain_error);
+}
+
+/*
+ * test the reductions against values computed
+ * manually using the foreach function
+ */
+TEST(matrix, reductions)
+{
+    for (int c = 0; c < TEST_CYCLES; c++) {
+        /*
+         * make a few of the matrices large enough
+         * for the work to be divided among threads
+         */
+        const int rows = 1 + rand() % ((c % 10) ? 100 : 1000);
+        const int cols = 1 + rand() % ((c % 10) ? 100 : 1000);
+
+        matrix<int> m(rows, cols);
+
+        /* small values, so that the sums don't overflow */
+        m.transform(
+            []
+            (const std::size_t /* ignored */,
+             const std::size_t /* ignored */,
+             const int /* ignored */)
+            {
+                return rand() % 2001 - 1000;
+            });
+
+        /*
+         * the transposition is stored differently,
+         * so test both orders
+         */
+        for (int t = 0; t < 2; t++) {
+            const matrix<int> n = t ? m.transpose() : m;
+            const std::size_t n_rows = n.size().first;
+            const std::size_t n_cols = n.size().second;
+
+            int sum = 0, min = n(0, 0), max = n(0, 0);
+            std::pair<std::size_t, std::size_t> argmin(0, 0), argmax(0, 0);
+            std::vector<int> row_sums(n_rows, 0), col_sums(n_cols, 0);
+
+            n.foreach(
+                [&]
+                (const std::size_t row,
+                 const std::size_t col,
+                 const int val)
+                {
+                    sum += val;
+
+                    /* foreach visits in row order, so keep the first */
+                    if (val < min) {
+                        min = val;
+                        argmin = std::make_pair(row, col);
+                    }
+                    if (val > max) {
+                        max = val;
+                        argmax = std::make_pair(row, col);
+                    }
+
+                    row_sums[row] += std::abs(val);
+                    col_sums[col] += std::abs(val);
+                });
+
+            EXPECT_EQ(n.sum(), sum);
+            EXPECT_EQ(n.min(), min);
+            EXPECT_EQ(n.max(), max);
+            EXPECT_EQ(n.argmin(), argmin);
+            EXPECT_EQ(n.argmax(), argmax);
+            EXPECT_EQ(n.norm_inf(),
+                      *std::max_element(row_sums.begin(), row_sums.end()));
+            EXPECT_EQ(n.norm1(),
+                      *std::max_element(col_sums.begin(), col_sums.end()));
+
+            if (n_rows == n_cols) {
+                int trace = 0;
+
+                for (std::size_t i = 0; i < n_rows; i++) {
+                    trace += n(i, i);
+                }
+
+                EXPECT_EQ(n.trace(), trace);
+            } else {
+                EXPECT_THROW(n.trace(), std::domain_error);
+            }
+        }
+    }
+
+    /* ties go to the first location in row order */
+    matrix<unsigned char> u(3, 4);
+    u(1, 3) = u(2, 0) = 7;
+    EXPECT_EQ(u.argmax().first, 1);
+    EXPECT_EQ(u.argmax().second, 3);
+    EXPECT_EQ(u.transpose().argmax().first, 0);
+    EXPECT_EQ(u.transpose().argmax().second, 2);
+    EXPECT_EQ(u.argmin().first, 0);
+    EXPECT_EQ(u.argmin().second, 0);
+    EXPECT_EQ(u.sum(), 14);
+    EXPECT_EQ(u.norm1(), 7);
+
+    /* the reductions of an empty matrix */
+    matrix<int> e;
+    EXPECT_EQ(e.sum(), 0);
+    EXPECT_EQ(e.trace(), 0);
+    EXPECT_EQ(e.norm1(), 0);
+    EXPECT_EQ(e.norm_inf(), 0);
+    EXPECT_THROW(e.min(), std::domain_error);
+    EXPECT_THROW(e.max(), std::domain_error);
+    EXPECT_THROW(e.argmin(), std::domain_error);
+    EXPECT_THROW(e.argmax(), std::domain_error);
+}
+
+/*
+ * test equality and hashing of matrices
+ * that are stored in different orders
+ */
+TEST(matrix, equality_order)
+{
+    for (int c = 0; c < TEST_CYCLES; c++) {
+        const int rows = 1 + rand() % 100;
+        const int cols = 1 + rand() % 100;
+
+        matrix<int> m(rows, cols), x(cols, rows);
+
+        /* make x hold the transposition of m, stored by rows */
+        m.transform(
+            [&x]
+            (const std::size_t row,
+             const std::size_t col,
+             const int /* ignored */)
+            {
+                const int v = rand();
+                x(col, row) = v;
+                return v;
+            });
+
+        /* n is stored by columns, but is equal to m */
+        matrix<int> n = x.transpose();
+
+        EXPECT_EQ(m, n);
+        EXPECT_EQ(n, m);
+        EXPECT_EQ(m.hash(), n.hash());
+
+        /* a matrix is always equal to itself */
+        EXPECT_EQ(m, m);
+
+        /* different dimensions are never equal */
+        if (rows != cols) {
+            EXPECT_NE(m, x);
+        }
+
+        /*
+         * change one random location and make sure that the
+         * inequality is caught. the hashes should differ, too
+         */
+        n(rand() % rows, rand() % cols)++;
+        EXPECT_NE(m, n);
+        EXPECT_NE(n, m);
+        EXPECT_NE(m.hash(), n.hash());
+    }
+}
+
+/*
+ * compute a determinant by cofactor expansion along the first
+ * row. this is hopelessly slow for anything but small matrices,
+ * but is entirely independent of the elimination algorithms.
+ */
+static long long cofactor(const matrix<long long> & m)
+{
+    const std::size_t n = m.size().first;
+    long long det = 0;
+
+    if (n == 1) {
+        return m(0, 0);
+    }
+
+    for (std::size_t k = 0; k < n; k++) {
+        matrix<long long> minor(n - 1, n - 1);
+
+        minor.transform(
+            [&m, k]
+            (const std::size_t row,
+             const std::size_t col,
+             const long long /* ignored */)
+            {
+                return m(row + 1, col < k ? col : col + 1);
+            });
+
+        det += ((k % 2) ? -1 : 1) * m(0, k) * cofactor(minor);
+    }
+
+    return det;
+}
+
+/*
+ * test the exact determinant, rank, and
+ * solution of linear systems with both methods
+ */
+TEST(matrix, exact_elimination)
+{
+    typedef matrix<long long> matrix_type;
+
+    for (int c = 0; c < TEST_CYCLES; c++) {
+        const int n = 1 + rand() % 6;
+        const int r = 1 + rand() % n;
+
+        matrix_type a(n, n), b(n, 1 + rand() % 3);
+        matrix_type x(n, r), y(r, n);
+
+        const std::function<long long(std::size_t, std::size_t,
+                                      long long)> fill =
+            []
+            (const std::size_t /* ignored */,
+             const std::size_t /* ignored */,
+             const long long /* ignored */)
+            {
+                return rand() % 21 - 10;
+            };
+
+        a.transform(fill);
+        b.transform(fill);
+        x.transform(fill);
+        y.transform(fill);
+
+        /* test both orders of storage */
+        if (c % 2) {
+            a = a.transpose().transpose();
+        } else {
+            matrix_type t(n, n);
+
+            t.transform(
+                [&a]
+                (const std::size_t row,
+                 const std::size_t col,
+                 const long long /* ignored */)
+                {
+                    return a(col, row);
+                });
+
+            a = t.transpose();
+        }
+
+        const long long det = cofactor(a);
+
+        EXPECT_EQ(a.determinant(), det);
+        EXPECT_EQ(a.determinant(matrix_type::MODULAR), det);
+        EXPECT_EQ(a.determinant(matrix_type::RANDOMIZED), det);
+
+        /* the rank of a product is limited by its factors */
+        const matrix_type p = x * y;
+
+        EXPECT_EQ(p.rank(), p.rank(matrix_type::MODULAR));
+        EXPECT_EQ(p.rank(), p.rank(matrix_type::RANDOMIZED));
+        EXPECT_LE(p.rank(), r);
+        EXPECT_EQ(x.rank(), x.transpose().rank(matrix_type::MODULAR));
+
+        /*
+         * the numerators divided by the denominator
+         * must satisfy the original system
+         */
+        if (det != 0) {
+            const std::pair<matrix_type, long long> s = a.solve(b);
+            const std::pair<matrix_type, long long> t =
+                a.solve(b, matrix_type::MODULAR);
+
+            EXPECT_EQ(s.second, std::abs(det));
+            EXPECT_EQ(a * s.first, b * s.second);
+            EXPECT_EQ(s.first, t.first);
+            EXPECT_EQ(s.second, t.second);
+            EXPECT_EQ(a.solve(b, matrix_type::RANDOMIZED), s);
+        } else {
+            EXPECT_LT(a.rank(), n);
+            EXPECT_THROW(a.solve(b), std::domain_error);
+            EXPECT_THROW(a.solve(b, matrix_type::MODULAR), std::domain_error);
+            EXPECT_THROW(a.solve(b, matrix_type::RANDOMIZED),
+                         std::domain_error);
+        }
+    }
+
+    /*
+     * the product of unit lower and upper triangular matrices
+     * has a determinant of one, but its elements, and those of
+     * the intermediate values, can be large
+     */
+    const int n = 40;
+    matrix_type l(n, n), u(n, n);
+
+    l.transform(
+        []
+        (const std::size_t row,
+         const std::size_t col,
+         const long long /* ignored */)
+        {
+            return (row == col) ? 1 : (row > col) ? rand() % 3 - 1 : 0;
+        });
+    u = l.transpose();
+
+    matrix_type m = l * u;
+
+    EXPECT_EQ(m.determinant(matrix_type::MODULAR), 1);
+    EXPECT_EQ(m.determinant(matrix_type::RANDOMIZED), 1);
+    EXPECT_EQ(m.rank(matrix_type::MODULAR), n);
+    EXPECT_EQ(m.rank(matrix_type::RANDOMIZED), n);
+
+    /* make the last row the sum of the first two */
+    for (int j = 0; j < n; j++) {
+        m(n - 1, j) = m(0, j) + m(1, j);
+    }
+
+    EXPECT_EQ(m.determinant(matrix_type::MODULAR), 0);
+    EXPECT_EQ(m.determinant(matrix_type::RANDOMIZED), 0);
+    EXPECT_EQ(m.rank(matrix_type::MODULAR), n - 1);
+    EXPECT_EQ(m.rank(matrix_type::RANDOMIZED), n - 1);
+
+    /*
+     * a matrix whose determinant is divisible by one of the primes
+     * is singular modulo that prime, which must then be replaced
+     */
+    matrix_type d(2, 2), e(2, 1);
+    d(0, 0) = 2147483647;
+    d(1, 1) = 3;
+    e(0, 0) = 5;
+    e(1, 0) = 7;
+
+    const std::pair<matrix_type, long long> sol =
+        d.solve(e, matrix_type::MODULAR);
+
+    EXPECT_EQ(sol.second, 3LL * 2147483647);
+    EXPECT_EQ(d * sol.first, e * sol.second);
+    EXPECT_EQ(d.solve(e, matrix_type::RANDOMIZED), sol);
+
+    /*
+     * the determinant of this matrix is the product of the first
+     * primes used, which divide it, and it's out of range, so it
+     * must not be mistaken for zero or for a singular matrix
+     */
+    const long long big[] = {
+        2147483647, 2147483629, 2147483587, 2147483579, 2147483563,
+    };
+    matrix_type g(5, 5), h(5, 1);
+    for (std::size_t i = 0; i < 5; i++) {
+        g(i, i) = big[i];
+        h(i, 0) = 1;
+    }
+    EXPECT_EQ(g.rank(matrix_type::MODULAR), 5);
+    EXPECT_EQ(g.rank(matrix_type::RANDOMIZED), 5);
+    EXPECT_THROW(g.rank(), std::overflow_error);
+    EXPECT_THROW(g.determinant(matrix_type::MODULAR), std::overflow_error);
+    EXPECT_THROW(g.determinant(matrix_type::RANDOMIZED),
+                 std::overflow_error);
+    EXPECT_THROW(g.determinant(), std::overflow_error);
+    EXPECT_THROW(g.solve(h, matrix_type::MODULAR), std::overflow_error);
+    EXPECT_THROW(g.solve(h, matrix_type::RANDOMIZED), std::overflow_error);
+
+    /* but the same matrix, made singular, must be found to be */
+    g(4, 4) = 0;
+    EXPECT_EQ(g.rank(matrix_type::MODULAR), 4);
+    EXPECT_EQ(g.rank(matrix_type::RANDOMIZED), 4);
+    EXPECT_EQ(g.determinant(matrix_type::MODULAR), 0);
+    EXPECT_EQ(g.determinant(matrix_type::RANDOMIZED), 0);
+    EXPECT_THROW(g.solve(h, matrix_type::MODULAR), std::domain_error);
+    EXPECT_THROW(g.solve(h, matrix_type::RANDOMIZED), std::domain_error);
+
+    /*
+     * the determinant of this matrix, 1 + p0 * p1 * p2 * p3 * p4, is
+     * one modulo each of the first primes, and isn't representable.
+     * it must not be taken to be one because it's one modulo a few
+     * more primes than are needed to cover the range of the elements.
+     */
+    matrix_type w(3, 3);
+    w(0, 0) = 1;
+    w(0, 1) = big[0] * big[1];
+    w(1, 1) = 1;
+    w(1, 2) = big[2] * big[3];
+    w(2, 0) = big[4];
+    w(2, 2) = 1;
+    EXPECT_THROW(w.determinant(), std::overflow_error);
+    EXPECT_THROW(w.determinant(matrix_type::MODULAR), std::overflow_error);
+    EXPECT_THROW(w.determinant(matrix_type::RANDOMIZED),
+                 std::overflow_error);
+
+    /* results and intermediate values must fit in the elements */
+    matrix<signed char> s(3, 3);
+    s.transform(
+        []
+        (const std::size_t row,
+         const std::size_t col,
+         const signed char /* ignored */)
+        {
+            return (row == col) ? 100 : 1;
+        });
+    EXPECT_THROW(s.determinant(), std::overflow_error);
+    EXPECT_THROW(s.determinant(matrix<signed char>::MODULAR),
+                 std::overflow_error);
+    EXPECT_EQ(s.rank(matrix<signed char>::MODULAR), 3);
+    EXPECT_EQ(s.rank(matrix<signed char>::RANDOMIZED), 3);
+
+    /* dimensional requirements */
+    EXPECT_EQ(matrix_type().determinant(), 1);
+    EXPECT_THROW(matrix_type(2, 3).determinant(), std::domain_error);
+    EXPECT_THROW(matrix_type(2, 2).solve(matrix_type(3, 1)),
+                 std::domain_error);
+    EXPECT_EQ(matrix_type(2, 3).rank(), 0);
+    EXPECT_EQ(matrix_type().solve(matrix_type()).second, 1);
+}